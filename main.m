@@ -5,10 +5,31 @@
 #import <objc/runtime.h>
 
 
-extern char *load_decrypted_vault(const char *password, unsigned char *salt);
-extern void save_encrypted_vault(const char *password, const char *data,
-                                 unsigned char *salt);
+extern int vault_each_meta(const char *password,
+                           void (*visit)(void *ctx, const char *service,
+                                         const char *username,
+                                         const char *const *tags),
+                           void *ctx);
+extern int vault_open_field(const char *password, const char *service,
+                            const char *field, char *out, size_t size);
+extern int vault_add_entry(const char *password, const char *service,
+                           const char *username, const char *secret);
 extern void copy_to_clipboard(const char *text);
+extern void secure_clear(void *ptr, size_t size);
+
+// rows hold metadata only; a password is opened when its row is picked
+static void collectEntry(void *ctx, const char *service, const char *username,
+                         const char *const *tags) {
+  NSMutableArray *entries = (__bridge NSMutableArray *)ctx;
+  NSMutableArray *tagList = [NSMutableArray array];
+  for (int i = 0; tags[i]; i++)
+    [tagList addObject:[NSString stringWithUTF8String:tags[i]]];
+  [entries addObject:@{
+    @"service" : [NSString stringWithUTF8String:service],
+    @"username" : [NSString stringWithUTF8String:username],
+    @"tags" : tagList
+  }];
+}
 
 @interface VaultApp : NSApplication
 @end
@@ -102,27 +123,12 @@ extern void copy_to_clipboard(const char *text);
 
 - (void)performLogin:(id)sender {
   NSString *pass = self.masterPassField.stringValue;
-  unsigned char salt[16];
-  char *data = load_decrypted_vault([pass UTF8String], salt);
+  NSMutableArray *loaded = [NSMutableArray array];
 
-  if (data) {
+  if (vault_each_meta([pass UTF8String], collectEntry,
+                      (__bridge void *)loaded) == 0) {
     self.masterPassword = pass;
-    self.entries = [NSMutableArray array];
-    NSString *vaultString = [NSString stringWithUTF8String:data];
-    NSArray *lines = [vaultString componentsSeparatedByString:@"\n"];
-    for (NSString *line in lines) {
-      NSArray *parts = [line
-          componentsSeparatedByCharactersInSet:[NSCharacterSet
-                                                   whitespaceCharacterSet]];
-      if (parts.count >= 3) {
-        [self.entries addObject:@{
-          @"service" : parts[0],
-          @"username" : parts[1],
-          @"password" : parts[2]
-        }];
-      }
-    }
-    free(data);
+    self.entries = loaded;
     self.filteredEntries = [self.entries copy];
     [self showDashboard];
   } else {
@@ -226,18 +232,17 @@ extern void copy_to_clipboard(const char *text);
     NSDictionary *newEntry = @{
       @"service" : svc.stringValue,
       @"username" : user.stringValue,
-      @"password" : pass.stringValue
+      @"tags" : @[]
     };
     [self.entries addObject:newEntry];
     [self filterEntries:nil];
 
-    NSMutableString *newData = [NSMutableString string];
-    for (NSDictionary *e in self.entries) {
-      [newData appendFormat:@"%@ %@ %@\n", e[@"service"], e[@"username"],
-                            e[@"password"]];
-    }
-    save_encrypted_vault([self.masterPassword UTF8String], [newData UTF8String],
-                         NULL);
+    // add under the vault's writer lock instead of rewriting our copy,
+    // so entries added elsewhere since unlock aren't dropped
+    vault_add_entry([self.masterPassword UTF8String],
+                    [svc.stringValue UTF8String],
+                    [user.stringValue UTF8String],
+                    [pass.stringValue UTF8String]);
   }
 }
 
@@ -304,7 +309,12 @@ extern void copy_to_clipboard(const char *text);
 
 - (BOOL)tableView:(NSTableView *)tableView shouldSelectRow:(NSInteger)row {
   NSDictionary *e = self.filteredEntries[row];
-  copy_to_clipboard([e[@"password"] UTF8String]);
+  char secret[4096];
+  if (vault_open_field([self.masterPassword UTF8String],
+                       [e[@"service"] UTF8String], "password", secret,
+                       sizeof(secret)) >= 0)
+    copy_to_clipboard(secret);
+  secure_clear(secret, sizeof(secret));
 
   
   NSView *v = nil;
@@ -0,0 +1,40 @@
+#!/bin/sh
+# re-adding an entry must keep what add doesn't set: tags, custom fields and
+# attachments; `vault field -NAME` drops a carried field
+# usage: tests/add_keeps_fields.sh [path/to/vault]
+set -e
+VAULT=${1:-./vault}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+export VAULT_PATH="$dir/vault" VAULT_PASSWORD_FD=3
+
+v() {
+  "$VAULT" "$@" 3<<PW
+pw
+PW
+}
+
+fail() {
+  echo "FAIL: $*" >&2
+  exit 1
+}
+
+v init >/dev/null
+echo "file body" >"$dir/f.txt"
+v add svc alice s3cret --tag prod --field stale=x >/dev/null
+v attach svc "$dir/f.txt" >/dev/null
+v add svc alice newpass >/dev/null
+
+v extract svc f.txt -o "$dir/out.txt" >/dev/null ||
+  fail "attachment lost on re-add"
+cmp -s "$dir/f.txt" "$dir/out.txt" || fail "attachment content differs"
+v find tag:prod | grep -q svc || fail "tag lost on re-add"
+v get svc | grep -q newpass || fail "new password not stored"
+v get svc | grep -q stale || fail "custom field lost on re-add"
+
+v field svc -stale >/dev/null
+v get svc | grep -q stale && fail "field -NAME kept the field"
+v extract svc f.txt -o "$dir/out2.txt" >/dev/null ||
+  fail "attachment lost on field edit"
+
+echo "ok"